@@ -13,7 +13,7 @@ expressions. For example:
 This tutorial demonstrates how to implement:
  - Binary operators  (eg. "2 + 3", "5 * 7".)
  - Unary operators  (eg. "-5", "-(10+20)".)
- - Parenthesized expressions  (which can be nested without limit.)
+ - Parenthesized expressions  (which can be nested up to a configurable depth.)
  - Operator precedence  (eg. '*' having a higher precedence than '+',
      ie. "1+2*3" is equivalent to "1+(2*3)" instead of "(1+2)*3".)
    Multiple operators can have the same precedence.
@@ -37,6 +37,9 @@ Some disadvantages:
    it the superior alternative, especially for simpler input formats.
  - It's not necessarily suitable for parsing some more complicated input formats.
  - Uses recursion, which may or may not be a problem depending on the target platform.
+   (This implementation limits the nesting depth, so that pathologically deeply nested input
+   strings result in an error message rather than a stack overflow, as long as the limit
+   is small enough for the stack size available.)
 
 In this example implementation the parser also evaluates the result as it is parsing the input.
 This is done just for the sake of simplicity. The parser can do other things, such as adding the
@@ -54,12 +57,24 @@ Note: There are some exercises for the reader at the end of this file.
   Some types and utility functions used in the parser
 -----------------------------------------------------------------------------------------------*/
 typedef long long ValueType;
-enum ParseErrorCode { ParseError_None, ParseError_Syntax, ParseError_Div0, ParseError_NoClosingParenthesis };
+enum ParseErrorCode { ParseError_None, ParseError_Syntax, ParseError_Div0, ParseError_NoClosingParenthesis,
+                      ParseError_TooDeep };
+
+/* Maximum nesting depth of parenthesized expressions and '^' operators. Each nesting level
+   uses some stack space, so this limit makes sure that pathologically deeply nested input
+   strings result in an error rather than a stack overflow. Adjust it to the stack size
+   available on the target platform.
+   (Each level of parentheses goes through five parsing functions: parseParentheses(),
+   parseAddSubtract(), parseMulDiv(), parseExponent() and parseUnaryMinus(). Depending on the
+   compiler and optimization level that's typically somewhere between 150 and 300 bytes of
+   stack per level, so the default limit needs about 300 KB of stack at most.) */
+enum { MaxNestingDepth = 1000 };
 
 struct ParseData
 {
     const char *currentPosition;
     enum ParseErrorCode errorCode;
+    int nestingDepth;
 };
 
 static const char* skipWhitespace(const char *str)
@@ -168,18 +183,30 @@ static ValueType parseExponent(struct ParseData *data)
     /* We achieve right-to-left precedence by using this clever trick: To parse the value after
        the '^' character we call *this* function rather than the next-higher-precedence one.
        (Note that we don't need a while loop here because this recursion is the loop.) */
+    if(++data->nestingDepth > MaxNestingDepth) { data->errorCode = ParseError_TooDeep; return 0; }
     ++data->currentPosition; /* Remember to skip the operator character */
     ValueType result2 = parseExponent(data);
     if(data->errorCode) return result;
+    --data->nestingDepth;
 
     /* Perform the operation. */
     if(result2 == 0) return 1;
     if(result2 < 0 && result == 0) { data->errorCode = ParseError_Div0; return 0; }
     if(result2 < 0) return 0;
 
-    const ValueType factor = result;
-    while(--result2) result *= factor;
-    return result;
+    /* Rather than multiplying the value by itself result2 times (which would take a very long
+       time with large exponents), we use exponentiation by squaring: For each bit of the
+       exponent we square the factor, and multiply it into the result if that bit is set.
+       This requires only about log2(result2) iterations. */
+    ValueType factor = result;
+    result = 1;
+    while(1)
+    {
+        if(result2 & 1) result *= factor;
+        result2 >>= 1;
+        if(!result2) return result;
+        factor *= factor;
+    }
 }
 
 /*-----------------------------------------------------------------------------------------------
@@ -221,9 +248,15 @@ static ValueType parseParentheses(struct ParseData *data)
     if(*data->currentPosition != '(')
         return parseValue(data);
 
+    /* Since each opening parenthesis makes the recursion deeper, we limit how deeply they can
+       be nested. */
+    if(++data->nestingDepth > MaxNestingDepth) { data->errorCode = ParseError_TooDeep; return 0; }
+
     /* If there was an opening parenthesis, we call the *lowest* precedence parsing function */
     ++data->currentPosition; /* Remember to skip the '(' character */
     const ValueType result = parseAddSubtract(data);
+    if(data->errorCode) return 0;
+    --data->nestingDepth;
 
     /* After the call we have to check that the next character is the closing parenthesis */
     data->currentPosition = skipWhitespace(data->currentPosition);
@@ -283,7 +316,7 @@ static int printErrorMsg(const char *str, const struct ParseData *data)
 {
     const char *const errorMessages[] =
     {
-        "Syntax error", "Division by 0", "Expecting )"
+        "Syntax error", "Division by 0", "Expecting )", "Expression nested too deeply"
     };
 
     printf("%s\n", str);
@@ -297,7 +330,7 @@ int main(int argc, char **argv)
 {
     for(int argInd = 1; argInd < argc; ++argInd)
     {
-        struct ParseData data = { argv[argInd], ParseError_None };
+        struct ParseData data = { argv[argInd], ParseError_None, 0 };
         const ValueType result = parseInputString(&data);
         if(data.errorCode) return printErrorMsg(argv[argInd], &data);
         printf("%lld\n", result);
@@ -362,4 +395,40 @@ int main(int argc, char **argv)
    to 0 if using integers, or -0.0625 if using floating point). For this reason this cannot
    be achieved by merely switching the precedences of the ^ operator and the unary minus.
    (Simply switching the precedences would make "2^-(1+3)" issue a syntax error.)
+
+6) Implement the conditional operator "a ? b : c" (which should have an even lower precedence
+   than '+' and '-'), so that the input string can be for example:
+
+     "(2*3-6) ? 100/(2*3-6) : 42"
+
+   Only one of the two branches is needed for the result, so the other one doesn't need to be
+   evaluated (and in the example above, the division by 0 in the untaken branch should not be
+   reported as an error). However, the untaken branch still has to be parsed, because the parser
+   needs to find where it ends (and it should still report syntax errors in it).
+   (Hint: Add a flag to struct ParseData that tells the parsing functions to only check the
+   syntax without evaluating anything, and set it while parsing the untaken branch. Remember
+   to restore its previous value afterwards, because conditional operators can be nested.)
+
+7) Every parsing function above checks data->errorCode after each call to another parsing
+   function, and returns immediately if an error happened. Try implementing the error handling
+   with setjmp() and longjmp() instead: parseInputString() calls setjmp() with a jmp_buf stored
+   in struct ParseData, and whenever a parsing function detects an error, it sets the error
+   code and calls longjmp() to return directly to parseInputString(), skipping all the
+   parsing functions in between. This way none of the parsing functions needs to check for
+   errors after calling another one.
+   (Note that data->currentPosition must still point to the location of the error when
+   longjmp() is called, so that printErrorMsg() shows the error in the same place as before.
+   Also note that this technique is only safe in C. In C++ longjmp() skips destructors, and
+   exceptions should be used instead.)
+
+8) Each level of parentheses in the input string makes the parser go through all the parsing
+   functions, from the lowest to the highest precedence one. Adding more precedence levels
+   makes every nesting level use more stack space (and more function calls).
+   Try implementing the binary operators with the "precedence climbing" technique instead:
+   a single parsing function takes the minimum precedence as a parameter, and looks up the
+   precedence and associativity of each binary operator from a table. Then each level of
+   parentheses requires only one or two function calls, regardless of how many precedence
+   levels there are. Measure how much the stack usage per nesting level decreases.
+   (Hint: To measure the stack usage, compare the address of a local variable in
+   parseValue() between two input strings that differ only in nesting depth.)
 */